@@ -0,0 +1,334 @@
+#!/usr/bin/env python3
+
+"""build and run the initial model setups, timing them and checking
+their output against the ci-benchmarks reference models.
+
+For each setup and each resolution we record the wall time, the peak
+resident memory, the number of EOS calls (if the setup was built
+with USE_INSTRUMENT=TRUE) and the "maximum HSE error" the setup
+reports.  At the CI resolution, the output model is compared column
+by column to the stored reference.
+
+Each run is appended to the report as one JSON record per line, so
+reports from different commits can simply be concatenated and
+compared.
+
+usage: run_benchmarks.py [options] [setup ...]
+
+run with --help for the options, and --list for the setups.
+"""
+
+import argparse
+import datetime
+import glob
+import json
+import os
+import platform
+import re
+import resource
+import shlex
+import shutil
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+TOP = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# these mirror the runs in .github/workflows.  nx is the resolution
+# of the CI run, output is the model it writes and reference is the
+# stored copy (None if there is no reference in the repo)
+
+SETUPS = {
+    "spherical": dict(
+        dir="spherical", inputs="inputs_rhoc_2e9_M_1.1", args=[], nx=2560,
+        output="WD_rhoc_2.e9_M_1.1.hse.dx2.00km",
+        reference="ci-benchmarks/WD_rhoc_2.e9_M_1.1.hse.dx2.00km"),
+    "sub_chandra": dict(
+        dir="sub_chandra", inputs="inputs.M_WD-1.1.M_He-0.05.CO.N14", args=[], nx=4096,
+        output="sub_chandra.M_WD-1.10.M_He-0.050.delta50.00km.temp_base-1.75e+08.hse.CO.N14.dx10.00km",
+        reference="ci-benchmarks/sub_chandra.M_WD-1.10.M_He-0.050.delta50.00km.hse.CO.N14.dx10.00km"),
+    "toy_atm": dict(
+        dir="toy_atm", inputs="inputs_xrb_mixed.hi_dens.tall.CNO", args=[], nx=1536,
+        output="toy_xrb.hi_dens.hse.tanh.delta_12.00cm.dx_3.00cm",
+        reference="ci-benchmarks/toy_xrb.hi_dens.hse.tanh.delta_12.00cm.dx_3.00cm"),
+    "test2": dict(
+        dir="test2", inputs="inputs.test2", args=[], nx=640,
+        output="model.hse.dx5.62km",
+        reference="ci-benchmarks/model.hse.dx5.62km"),
+    "ECSN": dict(
+        dir="ECSN", inputs="inputs", args=[], nx=10240,
+        output="ECSN-ONe6040-final.hse.dx24414.06cm",
+        reference="ci-benchmarks/ECSN-ONe6040-final.hse.dx24414.06cm"),
+    "ECSN_global": dict(
+        dir="ECSN", inputs="inputs", args=["problem.hse_solver=global"], nx=10240,
+        output="ECSN-ONe6040-final.hse.dx24414.06cm", reference=None),
+    "low_mass_convective_star": dict(
+        dir="low_mass_convective_star", inputs="inputs", args=[], nx=1024,
+        output="convective.hse.dx683.59km",
+        reference="ci-benchmarks/convective.hse.dx683.59km"),
+    "low_mass_convective_star_irreg": dict(
+        dir="low_mass_convective_star", inputs="inputs", args=["problem.use_irreg_grid=1"], nx=128,
+        output="convective.hse.irreg",
+        reference="ci-benchmarks/convective.hse.irreg"),
+    "urca": dict(
+        dir="urca/spherical", inputs="inputs", args=[], nx=1024,
+        output="WD_urca_nuc_cpp_hot.hse.1024",
+        reference="ci-benchmarks/WD_urca_nuc_cpp_hot.hse.1024"),
+    "massive_star": dict(
+        dir="massive_star", inputs="inputs", args=[], nx=16384,
+        output="15m_500_sec.aprox19.hse.dx20.00km", reference=None),
+    "lagrangian_planar": dict(
+        dir="lagrangian_planar", inputs="inputs_nova_t7", args=[], nx=15360,
+        output="glasner_T7.hse.dx10000.00cm", reference=None),
+    "kepler_hybrid": dict(
+        dir="kepler_hybrid", inputs="inputs", args=[], nx=1280,
+        output=None, reference=None),
+}
+
+# the default set are the setups that have a stored reference
+DEFAULT_SETUPS = [name for name, s in SETUPS.items() if s["reference"]]
+
+HSE_ERROR_RE = re.compile(r"maximum HSE error\s*=\s*(\S+)")
+
+
+def git_describe():
+    try:
+        return subprocess.run(["git", "describe", "--always", "--dirty"], cwd=TOP,
+                              capture_output=True, text=True, check=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def build(setup, make_args, jobs):
+    """run make in the setup's directory and return the executable"""
+
+    pdir = os.path.join(TOP, setup["dir"])
+    cmd = ["make", f"-j{jobs}"] + make_args
+    print(f"building {setup['dir']}: {' '.join(cmd)}", flush=True)
+    subprocess.run(cmd, cwd=pdir, check=True, stdout=subprocess.DEVNULL)
+    return find_executable(setup)
+
+
+def find_executable(setup):
+    """the most recently built initialmodel*.ex in the setup's directory"""
+
+    pdir = os.path.join(TOP, setup["dir"])
+    exes = glob.glob(os.path.join(pdir, "initialmodel*.ex"))
+    if not exes:
+        return None
+    return max(exes, key=os.path.getmtime)
+
+
+def make_run_dir(setup, run_dir):
+    """a fresh directory holding links to everything in the setup's directory"""
+
+    pdir = os.path.join(TOP, setup["dir"])
+    if os.path.isdir(run_dir):
+        shutil.rmtree(run_dir)
+    os.makedirs(run_dir)
+
+    for f in os.listdir(pdir):
+        if f == "ci-benchmarks" or f.endswith(".ex"):
+            continue
+        os.symlink(os.path.join(pdir, f), os.path.join(run_dir, f))
+
+
+def run(exe, setup, nx, run_dir, stack_limit):
+    """run one model and return its wall time, peak RSS (MB) and stdout"""
+
+    make_run_dir(setup, run_dir)
+
+    cmd = [exe, setup["inputs"]] + setup["args"] + [f"problem.nx={nx}"]
+
+    def set_stack():
+        resource.setrlimit(resource.RLIMIT_STACK, (stack_limit, stack_limit))
+
+    with open(os.path.join(run_dir, "stdout"), "w") as out:
+        start = time.perf_counter()
+        proc = subprocess.Popen(cmd, cwd=run_dir, stdout=out, stderr=subprocess.STDOUT,
+                                preexec_fn=set_stack)
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall = time.perf_counter() - start
+        proc.returncode = os.waitstatus_to_exitcode(status)
+
+    # ru_maxrss is kB on Linux and bytes on macOS
+    rss = usage.ru_maxrss / 1024.0
+    if sys.platform == "darwin":
+        rss /= 1024.0
+
+    with open(os.path.join(run_dir, "stdout")) as f:
+        stdout = f.read()
+
+    return proc.returncode, wall, rss, stdout
+
+
+def read_model(filename):
+    """read a model file: returns (names, data) where data[:, 0] is r"""
+
+    names = []
+    with open(filename) as f:
+        for line in f:
+            if not line.startswith("#"):
+                break
+            if "=" not in line:
+                names.append(line[1:].strip())
+
+    data = np.loadtxt(filename, comments="#", ndmin=2)
+    return ["r"] + names, data
+
+
+def compare(output, reference, rtol, atol):
+    """compare two models column by column.
+
+    A column passes if every |a - b| <= atol + rtol * |b|.  Returns a
+    dict with the overall result and the largest relative difference
+    in each column.
+    """
+
+    names, a = read_model(output)
+    ref_names, b = read_model(reference)
+
+    result = {"pass": True, "columns": {}}
+
+    if a.shape != b.shape or names != ref_names:
+        result["pass"] = False
+        result["error"] = f"shape {a.shape} vs {b.shape}, {len(names)} vs {len(ref_names)} variables"
+        return result
+
+    for n, name in enumerate(names):
+        diff = np.abs(a[:, n] - b[:, n])
+        scale = np.abs(b[:, n])
+        rel = np.where(scale > 0, diff / np.where(scale > 0, scale, 1.0), diff)
+        ok = bool(np.all(diff <= atol + rtol * scale))
+        result["columns"][name] = {"max_rel_diff": float(rel.max(initial=0.0)), "pass": ok}
+        result["pass"] = result["pass"] and ok
+
+    return result
+
+
+def main():
+
+    p = argparse.ArgumentParser(description=__doc__.split("\n\n")[0],
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("setups", nargs="*", help="setups to run (default: all with a reference)")
+    p.add_argument("--list", action="store_true", help="list the setups and exit")
+    p.add_argument("--nx-factors", default="1",
+                   help="comma-separated resolutions to run, as multiples of the CI nx (default: 1)")
+    p.add_argument("--repeat", type=int, default=1,
+                   help="runs of each case; the fastest is reported (default: 1)")
+    p.add_argument("--no-build", action="store_true",
+                   help="use the existing executables instead of running make")
+    p.add_argument("--make-args", default="",
+                   help='extra arguments to make, e.g. "USE_INSTRUMENT=TRUE"')
+    p.add_argument("-j", "--jobs", type=int, default=4, help="parallel make jobs")
+    p.add_argument("--rtol", type=float, default=1.e-10,
+                   help="relative tolerance for the reference comparison")
+    p.add_argument("--atol", type=float, default=0.0,
+                   help="absolute tolerance for the reference comparison")
+    p.add_argument("--run-dir", default="bench_runs",
+                   help="where the models are built (default: ./bench_runs)")
+    p.add_argument("--report", default="benchmarks.jsonl",
+                   help="report to append to (default: ./benchmarks.jsonl)")
+    p.add_argument("--stack", type=int, default=-1,
+                   help="stack limit in bytes for the runs (default: unlimited)")
+    args = p.parse_args()
+
+    if args.list:
+        for name, s in SETUPS.items():
+            ref = "reference" if s["reference"] else "timing only"
+            print(f"{name:32s} {s['dir']:26s} nx = {s['nx']:6d}  ({ref})")
+        return 0
+
+    names = args.setups or DEFAULT_SETUPS
+    for name in names:
+        if name not in SETUPS:
+            sys.exit(f"unknown setup {name}; use --list to see them")
+
+    nx_factors = [float(x) for x in args.nx_factors.split(",")]
+
+    stack = resource.RLIM_INFINITY if args.stack < 0 else args.stack
+    make_args = shlex.split(args.make_args)
+
+    commit = git_describe()
+    stamp = datetime.datetime.now(datetime.timezone.utc).isoformat(timespec="seconds")
+
+    records = []
+    failed = False
+
+    for name in names:
+        setup = SETUPS[name]
+
+        exe = find_executable(setup) if args.no_build else build(setup, make_args, args.jobs)
+        if exe is None:
+            print(f"{name}: no executable found, skipping")
+            failed = True
+            continue
+
+        for factor in nx_factors:
+            nx = max(int(round(setup["nx"] * factor)), 2)
+            run_dir = os.path.abspath(os.path.join(args.run_dir, name, f"nx_{nx}"))
+
+            best = None
+            for _ in range(max(args.repeat, 1)):
+                status, wall, rss, stdout = run(exe, setup, nx, run_dir, stack)
+                if status != 0:
+                    best = (status, wall, rss, stdout)
+                    break
+                if best is None or wall < best[1]:
+                    best = (status, wall, rss, stdout)
+
+            status, wall, rss, stdout = best
+
+            rec = {"time": stamp, "commit": commit, "host": platform.node(),
+                   "setup": name, "nx": nx, "status": status,
+                   "wall_seconds": wall, "peak_rss_mb": rss,
+                   "eos_calls": None, "max_hse_error": None, "reference": None}
+
+            errs = HSE_ERROR_RE.findall(stdout)
+            if errs:
+                rec["max_hse_error"] = float(errs[-1])
+
+            inst = os.path.join(run_dir, "instrument.json")
+            if os.path.isfile(inst):
+                with open(inst) as f:
+                    rec["eos_calls"] = json.load(f)["eos_calls"]["total"]
+
+            if status == 0 and factor == 1.0 and setup["reference"]:
+                output = os.path.join(run_dir, setup["output"])
+                reference = os.path.join(TOP, setup["dir"], setup["reference"])
+                if os.path.isfile(output):
+                    rec["reference"] = compare(output, reference, args.rtol, args.atol)
+                else:
+                    rec["reference"] = {"pass": False, "error": f"{setup['output']} not written"}
+
+            if status != 0 or (rec["reference"] and not rec["reference"]["pass"]):
+                failed = True
+
+            records.append(rec)
+
+            ref = "" if rec["reference"] is None else ("ref ok" if rec["reference"]["pass"] else "REF FAIL")
+            eos = "" if rec["eos_calls"] is None else f"{rec['eos_calls']:>10d} eos"
+            hse = "" if rec["max_hse_error"] is None else f"hse err {rec['max_hse_error']:10.3e}"
+            print(f"{name:32s} nx = {nx:6d}  {wall:9.3f} s  {rss:8.1f} MB  {eos}  {hse}  "
+                  f"{'' if status == 0 else f'EXIT {status}  '}{ref}", flush=True)
+
+            if rec["reference"] and not rec["reference"]["pass"]:
+                if "error" in rec["reference"]:
+                    print(f"    {rec['reference']['error']}")
+                for col, c in rec["reference"].get("columns", {}).items():
+                    if not c["pass"]:
+                        print(f"    {col:24s} max relative difference {c['max_rel_diff']:.3e}")
+
+    with open(args.report, "a") as f:
+        for rec in records:
+            f.write(json.dumps(rec) + "\n")
+
+    print(f"appended {len(records)} records to {args.report}")
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+
+"""convert initial models between the ASCII and binary formats.
+
+The binary format is written by write_model when
+problem.write_binary_model = 1 (see read_model.H for the layout).
+Binary -> ASCII writes 17 significant digits, so converting back
+gives the same doubles, and ASCII -> binary stores the ASCII values
+exactly.
+
+usage: hse_binary.py infile outfile
+
+The direction is picked from the format of infile.
+"""
+
+import struct
+import sys
+
+import numpy as np
+
+MAGIC = b"HSEBIN01"
+ENDIAN = 0x01020304
+
+
+def checksum(data):
+    """position-weighted sum of the 64-bit words of the data block"""
+    words = np.frombuffer(data, dtype=np.uint64)
+    k = np.arange(1, len(words) + 1, dtype=np.uint64)
+    with np.errstate(over="ignore"):
+        sum1 = int(words.sum(dtype=np.uint64))
+        sum2 = int((words * k).sum(dtype=np.uint64))
+    return (sum1 + 0x9E3779B97F4A7C15 * sum2) % 2**64
+
+
+def is_binary(filename):
+    with open(filename, "rb") as f:
+        return f.read(len(MAGIC)) == MAGIC
+
+
+def read_binary(filename):
+    """return (r, names, data, meta) where data[n, :] is variable names[n]"""
+
+    with open(filename, "rb") as f:
+        buf = f.read()
+
+    if buf[:8] != MAGIC:
+        sys.exit(f"{filename} is not a binary model")
+
+    endian, nvar, npts, irreg, _, dx, csum = struct.unpack_from("=IiqiidQ", buf, 8)
+    if endian != ENDIAN:
+        sys.exit(f"{filename} has the wrong byte order")
+
+    pos = 8 + struct.calcsize("=IiqiidQ")
+
+    def get_string(pos):
+        (n,) = struct.unpack_from("=i", buf, pos)
+        return buf[pos+4:pos+4+n].decode(), pos + 4 + n
+
+    network, pos = get_string(pos)
+    names = []
+    for _ in range(nvar):
+        name, pos = get_string(pos)
+        names.append(name)
+
+    pos += (8 - pos % 8) % 8
+
+    data = buf[pos:]
+    if len(data) != 8 * npts * (nvar + 1):
+        sys.exit(f"{filename} has the wrong size")
+    if checksum(data) != csum:
+        sys.exit(f"{filename} checksum does not match")
+
+    cols = np.frombuffer(data, dtype=np.float64).reshape(nvar + 1, npts)
+
+    meta = {"network": network, "dx": dx, "irreg": irreg}
+    return cols[0, :], names, cols[1:, :], meta
+
+
+def write_binary(filename, r, names, data, network="", dx=None, irreg=0):
+
+    npts = len(r)
+    if dx is None:
+        dx = 0.0 if irreg or npts < 2 else r[1] - r[0]
+
+    block = np.ascontiguousarray(np.vstack([r, data]), dtype=np.float64).tobytes()
+
+    header = MAGIC + struct.pack("=IiqiidQ", ENDIAN, len(names), npts,
+                                 irreg, 0, dx, checksum(block))
+    for s in [network] + list(names):
+        header += struct.pack("=i", len(s)) + s.encode()
+    header += b"\0" * ((8 - len(header) % 8) % 8)
+
+    with open(filename, "wb") as f:
+        f.write(header)
+        f.write(block)
+
+
+def read_ascii(filename):
+    """read a model in the ASCII format that read_file understands"""
+
+    with open(filename) as f:
+        npts = int(f.readline().split("=")[1])
+        nvar = int(f.readline().split("=")[1])
+        names = [f.readline().split("#", 1)[1].strip() for _ in range(nvar)]
+        vals = np.array(f.read().split(), dtype=np.float64)
+
+    vals = vals[:npts * (nvar + 1)].reshape(npts, nvar + 1)
+    return vals[:, 0], names, vals[:, 1:].T
+
+
+def write_ascii(filename, r, names, data):
+
+    with open(filename, "w") as f:
+        f.write(f"# npts = {len(r)}\n")
+        f.write(f"# num of variables = {len(names)}\n")
+        for name in names:
+            f.write(f"# {name}\n")
+        for i in range(len(r)):
+            f.write(" ".join(f"{v:24.17g}" for v in [r[i], *data[:, i]]) + "\n")
+
+
+def main():
+
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+
+    infile, outfile = sys.argv[1:]
+
+    if is_binary(infile):
+        r, names, data, _ = read_binary(infile)
+        write_ascii(outfile, r, names, data)
+    else:
+        r, names, data = read_ascii(infile)
+        write_binary(outfile, r, names, data)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,324 @@
+// A Python extension around one setup's model builder: read_file,
+// resample, write_model and the setup's init_1d.  This is built from
+// a setup directory with
+//
+//   make python USE_PYTHON=TRUE
+//
+// which gives initial_model.<ext-suffix>.so, compiled against that
+// setup's network, EOS and init_1d.H.  See python/README.md.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+
+#include <extern_parameters.H>
+
+#include <network.H>
+#include <eos.H>
+
+#include <init_1d.H>
+#include <pyramid.H>
+#include <read_model.H>
+#include <interpolate.H>
+#include <instrument.H>
+
+namespace py = pybind11;
+
+namespace {
+
+    bool initialized{false};
+
+    void require_initialized() {
+        if (! initialized) {
+            throw std::runtime_error("initial_model.initialize() has not been called");
+        }
+    }
+
+    // the model arrays are shared with NumPy: r is a 1-d view and
+    // state is an (npts, nvar) view in Fortran order, so state[i, n]
+    // is state(i, n) on the C++ side.  The views keep the model alive
+
+    py::array_t<Real> r_view(initial_model_t& model, py::handle owner) {
+        return py::array_t<Real>({model.npts}, {sizeof(Real)}, model.r.data(), owner);
+    }
+
+    py::array_t<Real> state_view(initial_model_t& model, py::handle owner) {
+        return py::array_t<Real>({model.npts, model::nvar},
+                                 {sizeof(Real), sizeof(Real) * model.npts},
+                                 model.state.column(0), owner);
+    }
+
+    // a new model with the zones of r and (optionally) the data of state
+
+    initial_model_t make_model(const py::array_t<Real, py::array::forcecast>& r,
+                               const py::object& state) {
+
+        auto rb = r.unchecked<1>();
+
+        initial_model_t model;
+        model.npts = static_cast<int>(rb.shape(0));
+        model.r = model_array_t(model.npts);
+        model.state = model_state_t(model.npts, model::nvar);
+
+        for (int i = 0; i < model.npts; ++i) {
+            model.r(i) = rb(i);
+        }
+
+        if (! state.is_none()) {
+            auto s = py::array_t<Real, py::array::forcecast>::ensure(state);
+            if (! s || s.ndim() != 2 || s.shape(0) != model.npts || s.shape(1) != model::nvar) {
+                throw std::invalid_argument("state must have shape (len(r), nvar)");
+            }
+            auto sb = s.unchecked<2>();
+            for (int n = 0; n < model::nvar; ++n) {
+                for (int i = 0; i < model.npts; ++i) {
+                    model.state(i, n) = sb(i, n);
+                }
+            }
+        }
+
+        return model;
+    }
+
+    std::string parameter_key(const std::string& name) {
+        return name.find('.') == std::string::npos ? "problem." + name : name;
+    }
+
+    // calls f when it goes out of scope, so whatever a call changes
+    // for its duration is put back even if the C++ throws
+
+    template <typename F>
+    class scope_exit_t {
+    public:
+        explicit scope_exit_t(F f) : m_f(std::move(f)) {}
+        ~scope_exit_t() { m_f(); }
+
+        scope_exit_t(const scope_exit_t&) = delete;
+        scope_exit_t& operator=(const scope_exit_t&) = delete;
+
+    private:
+        F m_f;
+    };
+
+}
+
+
+PYBIND11_MODULE(initial_model, m) {
+
+    m.doc() = "the model builder of one initial_models setup";
+
+    m.def("initialize",
+          [] (const std::string& inputs, const std::vector<std::string>& args) {
+
+              if (initialized) {
+                  throw std::runtime_error("initial_model is already initialized");
+              }
+
+              // errors should come back as Python exceptions, and
+              // Python keeps its own signal handlers
+
+              static std::vector<std::string> argv_s;
+              argv_s = {"initial_model"};
+              if (! inputs.empty()) {
+                  argv_s.push_back(inputs);
+              }
+              argv_s.push_back("amrex.throw_exception=1");
+              argv_s.push_back("amrex.signal_handling=0");
+              argv_s.insert(argv_s.end(), args.begin(), args.end());
+
+              static std::vector<char*> argv_p;
+              argv_p.clear();
+              for (auto& a : argv_s) {
+                  argv_p.push_back(const_cast<char*>(a.c_str()));
+              }
+              argv_p.push_back(nullptr);
+
+              int argc = static_cast<int>(argv_s.size());
+              char** argv = argv_p.data();
+
+              amrex::Initialize(argc, argv);
+
+              init_extern_parameters();
+
+              eos_init(problem_rp::small_temp, problem_rp::small_dens);
+
+              initialized = true;
+
+              py::module_::import("atexit").attr("register")(py::cpp_function([] () {
+                  if (initialized) {
+                      amrex::Finalize();
+                      initialized = false;
+                  }
+              }));
+          },
+          py::arg("inputs") = "", py::arg("args") = std::vector<std::string>{},
+          "start AMReX, read the inputs file (and any name=value overrides in args), "
+          "and initialize the runtime parameters and the EOS");
+
+    m.def("set_parameter",
+          [] (const std::string& name, const py::object& value) {
+              require_initialized();
+
+              std::string key = parameter_key(name);
+              auto dot = key.find('.');
+
+              std::string v = py::isinstance<py::bool_>(value) ?
+                  (value.cast<bool>() ? "1" : "0") : py::str(value).cast<std::string>();
+
+              amrex::ParmParse pp(key.substr(0, dot));
+              pp.add(key.substr(dot+1).c_str(), v);
+
+              init_extern_parameters();
+          },
+          py::arg("name"), py::arg("value"),
+          "set a runtime parameter, e.g. set_parameter('nx', 640) or "
+          "set_parameter('problem.model_file', 'model.dat')");
+
+    m.def("get_parameter",
+          [] (const std::string& name) -> py::object {
+              require_initialized();
+
+              std::string key = parameter_key(name);
+              auto dot = key.find('.');
+
+              amrex::ParmParse pp(key.substr(0, dot));
+              std::string v;
+              if (! pp.query(key.substr(dot+1).c_str(), v)) {
+                  return py::none();
+              }
+              return py::str(v);
+          },
+          py::arg("name"),
+          "the value of a runtime parameter set in the inputs or with "
+          "set_parameter, as a string, or None");
+
+    // the layout of the model variables
+
+    py::dict variables;
+    variables["density"] = model::idens;
+    variables["temperature"] = model::itemp;
+    variables["pressure"] = model::ipres;
+    variables["entropy"] = model::ientr;
+    variables["Ye"] = model::iyef;
+    for (int n = 0; n < NumSpec; ++n) {
+        variables[py::str(spec_names_cxx[n])] = model::ispec + n;
+    }
+    m.attr("variables") = variables;
+    m.attr("nvar") = model::nvar;
+
+    py::class_<initial_model_t>(m, "Model",
+                                "a model: zone coordinates r and an (npts, nvar) state, "
+                                "both shared with the C++ arrays")
+        .def(py::init(&make_model), py::arg("r"), py::arg("state") = py::none())
+        .def_readonly("npts", &initial_model_t::npts)
+        .def_property_readonly("r", [] (py::object self) {
+            return r_view(self.cast<initial_model_t&>(), self);
+        })
+        .def_property_readonly("state", [] (py::object self) {
+            return state_view(self.cast<initial_model_t&>(), self);
+        })
+        .def("__getitem__", [variables] (py::object self, const std::string& name) {
+            auto& model = self.cast<initial_model_t&>();
+            if (! variables.contains(name)) {
+                throw py::key_error(name);
+            }
+            int n = variables[py::str(name)].cast<int>();
+            return py::array_t<Real>({model.npts}, {sizeof(Real)}, model.state.column(n), self);
+        })
+        .def("__len__", [] (const initial_model_t& model) { return model.npts; });
+
+    m.def("read_file",
+          [] (const std::string& filename) {
+              require_initialized();
+              initial_model_t model;
+              read_file(filename, model);
+              return model;
+          },
+          py::arg("filename"),
+          "read an ASCII or binary model file");
+
+    m.def("resample",
+          [] (const initial_model_t& model, const py::array_t<Real, py::array::forcecast>& r,
+              const std::string& scheme, const bool extrapolate_top) {
+              require_initialized();
+              initial_model_t out = make_model(r, py::none());
+              resample(out.r, out.npts, model, out.state, extrapolate_top,
+                       get_interp_scheme(scheme));
+              return out;
+          },
+          py::arg("model"), py::arg("r"), py::arg("scheme") = "linear",
+          py::arg("extrapolate_top") = false,
+          "map every variable of model onto the (increasing) coordinates r");
+
+    m.def("write_model",
+          [] (const std::string& name, const initial_model_t& model, const bool write_ye) {
+              require_initialized();
+
+              // write_model writes problem.nx zones
+
+              {
+                  const int nx_save = problem_rp::nx;
+                  scope_exit_t restore_nx([nx_save] () { problem_rp::nx = nx_save; });
+
+                  if (! problem_rp::use_irreg_grid) {
+                      problem_rp::nx = model.npts;
+                  } else if (model.npts != get_irreg_nr()) {
+                      throw std::invalid_argument("model does not have the irregular grid's number of zones");
+                  }
+                  write_model(name, model.r, model.state, write_ye);
+              }
+
+              // the file is there when we return
+              py::gil_scoped_release release;
+              model_writer::wait_for_writes();
+          },
+          py::arg("name"), py::arg("model"), py::arg("write_ye") = false,
+          "write model with the usual naming (model file root, name, dx)");
+
+    m.def("build",
+          [] () {
+              require_initialized();
+
+              // keep every model the driver writes.  Capturing stops
+              // when we return, or if the driver throws, so later
+              // write_model calls do not copy their models
+
+              auto& captured = model_io::captured_models();
+              captured.enabled = true;
+              captured.models.clear();
+
+              scope_exit_t stop_capture([&captured] () {
+                  captured.enabled = false;
+                  captured.models.clear();
+              });
+
+              {
+                  py::gil_scoped_release release;
+                  run_pyramid(init_1d);
+                  model_writer::wait_for_writes();
+              }
+
+              captured.enabled = false;
+
+              py::dict models;
+              for (auto& c : captured.models) {
+                  models[py::str(c.filename)] = py::cast(std::move(c.model));
+              }
+
+              instrument::write_report();
+
+              return models;
+          },
+          "run this setup's init_1d (or the pyramid of problem.nx_levels) with the "
+          "current parameters.  The output files are written as usual, and the "
+          "models are also returned, as a dict of output file name to Model");
+}
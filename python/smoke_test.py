@@ -0,0 +1,60 @@
+"""A short check of the initial_model module.  Run it from the setup
+directory the module was built in, e.g. for spherical:
+
+   python3 ../python/smoke_test.py inputs_rhoc_2e9_M_1.1 \\
+       ci-benchmarks/WD_rhoc_2.e9_M_1.1.hse.dx2.00km
+
+It reads the benchmark model, resamples it, builds the model of the
+inputs file, and checks that the model we built matches the benchmark.
+"""
+
+import os
+import sys
+
+import numpy as np
+
+import initial_model as im
+
+
+def main(inputs, benchmark):
+
+    im.initialize(inputs)
+
+    # reading and resampling
+
+    bench = im.read_file(benchmark)
+    assert bench.npts > 0
+    assert bench.state.shape == (bench.npts, im.nvar)
+    assert np.all(np.diff(bench.r) > 0.0)
+
+    r = np.linspace(bench.r[0], bench.r[-1], bench.npts // 2)
+    coarse = im.resample(bench, r)
+    assert coarse.npts == len(r)
+    assert np.all(np.isfinite(coarse["density"]))
+
+    # building
+
+    models = im.build()
+    assert models, "build() returned no models"
+
+    name = os.path.basename(benchmark)
+    built = [m for f, m in models.items() if os.path.basename(f) == name]
+    assert built, f"build() did not write {name}: {list(models)}"
+
+    model = built[0]
+    assert model.npts == bench.npts
+    for var in ("density", "temperature", "pressure"):
+        # the benchmark is written with 12 significant digits
+        assert np.allclose(model[var], bench[var], rtol=1.e-10, atol=0.0), var
+
+    # the models are views of the C++ arrays, so they stay valid after
+    # the dict is gone
+
+    del models
+    assert np.all(np.isfinite(model["density"]))
+
+    print("initial_model smoke test passed")
+
+
+if __name__ == "__main__":
+    main(sys.argv[1], sys.argv[2])
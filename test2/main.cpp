@@ -25,6 +25,10 @@
 #include <network.H>
 #include <eos.H>
 #include <init_1d.H>
+#include <sweep.H>
+#include <server.H>
+#include <pyramid.H>
+#include <instrument.H>
 
 std::string inputs_name = "";
 
@@ -54,7 +58,18 @@ main (int   argc,
 
   eos_init(problem_rp::small_temp, problem_rp::small_dens);
 
-  init_1d();
+  // either build a single model (or a pyramid of resolutions of it),
+  // a sweep over a set of parameters, or a model for each request
+  // sent to a server
+
+  if (server_requested()) {
+      run_server([] () { run_pyramid(init_1d); });
+  } else if (sweep_requested()) {
+      run_sweep([] () { run_pyramid(init_1d); });
+  } else {
+      run_pyramid(init_1d);
+      instrument::write_report();
+  }
 
   amrex::Finalize();
 